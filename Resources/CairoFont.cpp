@@ -66,10 +66,120 @@ CairoFont::CairoFont(string filename)
 }
 
 void CairoFont::Init() {
-    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
-    cr = cairo_create (surface);
+    quality = FONT_QUALITY_BEST;
     slant = CAIRO_FONT_SLANT_NORMAL;
     weight = CAIRO_FONT_WEIGHT_NORMAL;
+    SelectScaledFont();
+}
+
+/**
+ * Select the scaled font used for measuring and rendering text for
+ * the current face, size, style and quality. Fonts are looked up in
+ * the cache before a new one is created, as creating a font measures
+ * its glyph table.
+ *
+ **/
+void CairoFont::SelectScaledFont() {
+    ScaledFontKey key;
+    key.ptsize = ptsize;
+    key.style = style;
+    key.quality = quality;
+    map<ScaledFontKey, ScaledFontPtr>::iterator itr = scaled.find(key);
+    if (itr != scaled.end()) {
+        current = itr->second;
+        return;
+    }
+    // font textures keep the fonts of their recorded text alive
+    if (scaled.size() >= MAX_SCALED_FONTS) scaled.clear();
+    current = ScaledFontPtr(new ScaledFont
+        (CreateScaledFont(filename, slant, weight, ptsize, quality)));
+    scaled[key] = current;
+}
+
+/**
+ * Measure the Latin-1 glyphs of a scaled font. Takes ownership of
+ * the cairo scaled font.
+ *
+ **/
+CairoFont::ScaledFont::ScaledFont(cairo_scaled_font_t* font)
+    : font(font)
+{
+    cairo_text_extents_t te;
+    for (unsigned int c = 0; c < 256; ++c) {
+        // utf-8 encoding of the code point
+        char s[3] = { 0, 0, 0 };
+        if (c < 0x80) {
+            s[0] = c;
+        } else {
+            s[0] = 0xc0 | (c >> 6);
+            s[1] = 0x80 | (c & 0x3f);
+        }
+        cairo_scaled_font_text_extents(font, s, &te);
+        glyphs[c].x_bearing = te.x_bearing;
+        glyphs[c].y_bearing = te.y_bearing;
+        glyphs[c].width = te.width;
+        glyphs[c].height = te.height;
+        glyphs[c].x_advance = te.x_advance;
+    }
+}
+
+CairoFont::ScaledFont::~ScaledFont() {
+    cairo_scaled_font_destroy(font);
+}
+
+/**
+ * Compute the extents of a string from the glyph table, as cairo
+ * would lay out the glyphs. Strings outside Latin-1 are measured by
+ * cairo.
+ *
+ **/
+void CairoFont::ScaledFont::TextExtents(const string& s, 
+                                        cairo_text_extents_t& te) const {
+    double x = 0;
+    double x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    bool ink = false;
+    for (string::size_type i = 0; i < s.size(); ++i) {
+        unsigned char c = s[i];
+        if (c >= 0x80) {
+            // only two byte sequences of Latin-1 are in the table
+            if ((c != 0xc2 && c != 0xc3) || i + 1 >= s.size() ||
+                ((unsigned char)s[i+1] & 0xc0) != 0x80) {
+                cairo_scaled_font_text_extents(font, s.c_str(), &te);
+                return;
+            }
+            c = ((c & 0x03) << 6) | ((unsigned char)s[++i] & 0x3f);
+        }
+        const GlyphMetrics& g = glyphs[c];
+        if (g.width > 0 && g.height > 0) {
+            double gx0 = x + g.x_bearing, gx1 = gx0 + g.width;
+            double gy0 = g.y_bearing, gy1 = gy0 + g.height;
+            if (!ink) {
+                x0 = gx0; y0 = gy0; x1 = gx1; y1 = gy1;
+                ink = true;
+            } else {
+                if (gx0 < x0) x0 = gx0;
+                if (gy0 < y0) y0 = gy0;
+                if (gx1 > x1) x1 = gx1;
+                if (gy1 > y1) y1 = gy1;
+            }
+        }
+        x += g.x_advance;
+    }
+    te.x_bearing = x0;
+    te.y_bearing = y0;
+    te.width = x1 - x0;
+    te.height = y1 - y0;
+    te.x_advance = x;
+    te.y_advance = 0;
+}
+
+/**
+ * Destroy the cached scaled fonts.
+ *
+ **/
+void CairoFont::DestroyScaledFonts() {
+    scaled.clear();
+    current.reset();
 }
 
 /**
@@ -78,8 +188,6 @@ void CairoFont::Init() {
  **/
 CairoFont::~CairoFont() {
     Unload();
-    cairo_destroy(cr);
-    cairo_surface_destroy(surface);
 }
 
 /**
@@ -92,26 +200,26 @@ void CairoFont::FireChangedEvent() {
 }
 
 /**
- * Load the Cairo_ttf resources. 
+ * Load the scaled font used for measuring text.
  *
- * You should specify the font point size
- * before loading the font as Cairo_ttf requires this upon
- * initialization.
- *
- * Call this function before any calls to CreateFontTexture. 
+ * The font is loaded upon construction, so calling Load is only
+ * needed after an Unload. Do not measure text from other threads
+ * while loading.
  * 
  **/
 void CairoFont::Load() {
+    if (current) return;
+    SelectScaledFont();
 }
 
 /**
- * Unload the Cairo_ttf font resources.
+ * Unload the scaled font used for measuring text.
  * 
- * If the font is not loaded when an associated CairoFontTexture needs
- * rendering an exception will be raised.
+ * Font textures keep their own surfaces and are not affected.
  *
  **/
 void CairoFont::Unload() {
+    DestroyScaledFonts();
 }
 
 /**
@@ -121,32 +229,69 @@ void CairoFont::Unload() {
 void CairoFont::RenderText(string s, IFontTextureResourcePtr texr, int x, int y) {
     CairoFontTexture* tex = dynamic_cast<CairoFontTexture*>(texr.get());
     if (!tex) throw Exception("Font Texture not compatible with SDLFontResource.");
-    cairo_t *tcr = tex->cr;
-    cairo_text_extents_t te;
-    cairo_font_extents_t fe;
-    cairo_font_extents (tcr, &fe);
-    cairo_set_operator (tcr, CAIRO_OPERATOR_OVER);
-    cairo_set_source_rgb (tcr, colr[0], colr[1], colr[2]);
-    cairo_select_font_face (tcr, filename.c_str(),
-                            slant, weight);
-    cairo_set_font_size (tcr, ptsize);
-    cairo_text_extents (tcr, s.c_str(), &te);
-    cairo_move_to (tcr, x-te.x_bearing, y-te.y_bearing - fe.descent+fe.height/2);
-    cairo_show_text (tcr, s.c_str());
+    if (!current) Load();
+    TextOp op;
+    op.text = s;
+    op.x = x;
+    op.y = y;
+    // share the cached scaled font of the current settings
+    op.font = current;
+    op.colr = colr;
+    // replay an evicted texture while its recording is complete
+    tex->Restore();
+    if (tex->recording) {
+        if (tex->ops.size() < CairoFontTexture::MAX_TEXT_OPS)
+            tex->ops.push_back(op);
+        else {
+            // too much to replay, pin the texture until the next clear
+            tex->ops.clear();
+            tex->recording = false;
+        }
+    }
+    tex->Draw(op);
     tex->FireChangedEvent(0, 0, tex->width, tex->height);
 }
 
+/**
+ * Get the dimensions of a string rendered with this font.
+ *
+ * An unloaded font is loaded first. Several threads may measure at
+ * once when the font is already loaded, see CairoFont.
+ * 
+ **/
 Vector<2,int> CairoFont::TextDim(string s) {
+    if (!current) Load();
     cairo_text_extents_t te;
-    cairo_select_font_face (cr, filename.c_str(),
-                            slant, weight);
-    cairo_set_font_size (cr, ptsize);
-    cairo_text_extents (cr, s.c_str(), &te);
+    current->TextExtents(s, te);
     Vector<2,int> dim((int)(te.width-te.x_bearing),
 		      (int)(te.height-te.y_bearing));
     return dim;
 }
 
+/**
+ * Get the dimensions of several strings rendered with this font.
+ *
+ * An unloaded font is loaded first. Several threads may measure at
+ * once when the font is already loaded, see CairoFont.
+ * 
+ * @param strings the strings to measure.
+ * @return the dimensions in the order of the strings.
+ **/
+vector<Vector<2,int> > CairoFont::TextDim(const vector<string>& strings) {
+    if (!current) Load();
+    const ScaledFont* font = current.get();
+    vector<Vector<2,int> > dims;
+    dims.reserve(strings.size());
+    cairo_text_extents_t te;
+    for (vector<string>::const_iterator itr = strings.begin();
+         itr != strings.end(); ++itr) {
+        font->TextExtents(*itr, te);
+        dims.push_back(Vector<2,int>((int)(te.width-te.x_bearing),
+                                     (int)(te.height-te.y_bearing)));
+    }
+    return dims;
+}
+
 
 /**
  * Create a new CairoFontTexture of fixed size. The texture will be bound to this
@@ -163,13 +308,15 @@ IFontTextureResourcePtr CairoFont::CreateFontTexture(int width, int height) {
 }
 
 /**
- * Set the size of the CairoFont. This will reload the CairoFont as this
- * is required by Cairo_ttf.
+ * Set the size of the CairoFont. The first use of a size measures
+ * its glyph table, later switches back to it are cheap, see
+ * CairoFont.
  * 
  * @param ptsize the point size of the CairoFont.
  **/
 void CairoFont::SetSize(int ptsize) {
     this->ptsize = ptsize;
+    if (current) SelectScaledFont();
 }
     
 /**
@@ -198,6 +345,7 @@ void CairoFont::SetStyle(int style) {
     if (style & FONT_STYLE_ITALIC) {
         slant = CAIRO_FONT_SLANT_ITALIC;
     }
+    if (current) SelectScaledFont();
     FireChangedEvent();
 }
     
@@ -232,6 +380,29 @@ Vector<3,float> CairoFont::GetColor() {
     return colr;
 }
 
+/**
+ * Set the rendering quality of the CairoFont. Use a faster tier for
+ * text that changes often and is not read closely, such as counters.
+ * The scaled fonts are cached, so switching back and forth is
+ * cheap.
+ * 
+ * @param quality the quality tier of the CairoFont
+ **/
+void CairoFont::SetQuality(CairoFontQuality quality) {
+    this->quality = quality;
+    if (current) SelectScaledFont();
+    FireChangedEvent();
+}
+
+/**
+ * Get the current rendering quality of the CairoFont. 
+ * 
+ * @return the quality tier of the CairoFont.
+ **/
+CairoFontQuality CairoFont::GetQuality() {
+    return quality;
+}
+
 // font texture implementation
 CairoFont::CairoFontTexture::CairoFontTexture(int width, int height)
     : IFontTextureResource()
@@ -241,25 +412,100 @@ CairoFont::CairoFontTexture::CairoFontTexture(int width, int height)
     this->height = height;
     channels = 4;
     this->format = RGBA;
+    // the surface is allocated on first use, see Restore
+    surface = NULL;
+    cr = NULL;
+    data = NULL;
+    recording = true;
+}
+
+CairoFont::CairoFontTexture::~CairoFontTexture() {
+    Unload();
+}
+
+/**
+ * Make sure the texture surface is resident. A newly allocated
+ * surface is cleared and all text rendered since the last clear is
+ * drawn again.
+ *
+ * @return true if a new surface was allocated.
+ */
+bool CairoFont::CairoFontTexture::Restore() {
+    if (surface) {
+        CairoMemoryManager::Touch(this);
+        return false;
+    }
     surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    cairo_status_t status = cairo_surface_status(surface);
+    if (status != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+        surface = NULL;
+        throw Exception("Could not create font texture: " + 
+                        string(cairo_status_to_string(status)));
+    }
     cr = cairo_create (surface);
     data = cairo_image_surface_get_data(surface);
+    CairoMemoryManager::Allocated(this);
+    for (vector<TextOp>::iterator itr = ops.begin(); itr != ops.end(); ++itr)
+        Draw(*itr);
+    return true;
 }
 
-CairoFont::CairoFontTexture::~CairoFontTexture() {
+void CairoFont::CairoFontTexture::Draw(TextOp& op) {
+    cairo_text_extents_t te;
+    cairo_font_extents_t fe;
+    cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+    cairo_set_source_rgb (cr, op.colr[0], op.colr[1], op.colr[2]);
+    cairo_set_scaled_font (cr, op.font->font);
+    cairo_scaled_font_extents (op.font->font, &fe);
+    op.font->TextExtents(op.text, te);
+    cairo_move_to (cr, op.x-te.x_bearing, op.y-te.y_bearing - fe.descent+fe.height/2);
+    cairo_show_text (cr, op.text.c_str());
+    cairo_surface_flush(surface);
+}
+
+void CairoFont::CairoFontTexture::Load() {
+    Restore();
+}
+
+void CairoFont::CairoFontTexture::Unload() {
+    if (!surface) return;
+    CairoMemoryManager::Released(this);
     cairo_destroy(cr);
     cairo_surface_destroy(surface);
+    cr = NULL;
+    surface = NULL;
+    data = NULL;
 }
 
 void CairoFont::CairoFontTexture::Clear(Vector<4,float> color) {
     clearcol = color;
-    cairo_set_source_rgba (cr, color[0], color[1], color[2], color[3]);
-    cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
-    cairo_paint(cr);
-    cairo_surface_flush(surface);
+    ops.clear();
+    recording = true;
+    // the surface is allocated clear on first use, see Restore
+    if (surface) {
+        CairoMemoryManager::Touch(this);
+        cairo_set_source_rgba (cr, color[0], color[1], color[2], color[3]);
+        cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+        cairo_paint(cr);
+        cairo_surface_flush(surface);
+    }
     FireChangedEvent(0, 0, width, height);
 }
 
+unsigned int CairoFont::CairoFontTexture::GetBufferSize() {
+    if (!surface) return 0;
+    return cairo_image_surface_get_stride(surface) * height;
+}
+
+bool CairoFont::CairoFontTexture::IsEvictable() {
+    return recording;
+}
+
+void CairoFont::CairoFontTexture::Evict() {
+    Unload();
+}
+
 void CairoFont::CairoFontTexture::FireChangedEvent(int x, int y, int w, int h) {
     changedEvent.
         Notify(Texture2DChangedEventArg(ITexture2DPtr(weak_this), x, y, w, h));
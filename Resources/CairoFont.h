@@ -16,9 +16,13 @@
 #include <Resources/IFontResource.h>
 #include <Resources/IFontTextureResource.h>
 #include <Resources/IResourcePlugin.h>
+#include <Resources/CairoMemoryManager.h>
+#include <Resources/CairoFontQuality.h>
 #include <Core/IListener.h>
 #include <Math/Vector.h>
 #include <string.h>
+#include <vector>
+#include <map>
 
 #include <boost/weak_ptr.hpp>
 #include <boost/shared_ptr.hpp>
@@ -37,26 +41,107 @@ typedef boost::shared_ptr<CairoFont> CairoFontPtr;
 /**
  * Cairo Font resource.
  *
+ * Font textures should be cleared before their text is rendered
+ * again, otherwise they keep growing their recording until it is
+ * dropped and the texture can no longer be evicted.
+ *
+ * Text measurement reads an immutable table of glyph metrics and may
+ * be done from several threads at once without locking, as long as
+ * the font is loaded and not modified at the same time. Text outside
+ * Latin-1 falls back to cairo, which serializes all threads measuring
+ * with the same font.
+ *
+ * Measuring the glyph table is done once per size, style and quality
+ * tier. The most recently used combinations are cached, so switching
+ * a shared font between a few sizes is cheap after the first use.
+ *
  * @class CairoFont CairoFont.h Resources/CairoFont.h
  */
 class CairoFont : public IFontResource {
 private:
-    class CairoFontTexture : public IFontTextureResource {
+    /**
+     * Metrics of a single glyph.
+     */
+    struct GlyphMetrics {
+        double x_bearing, y_bearing;
+        double width, height;
+        double x_advance;
+    };
+
+    /**
+     * Cairo scaled font with the metrics of the Latin-1 glyphs
+     * measured up front. The table is never modified after
+     * construction, so unlike the glyph cache of the cairo scaled
+     * font it can be read by several threads without locking.
+     */
+    class ScaledFont {
+    private:
+        GlyphMetrics glyphs[256];
+        ScaledFont(const ScaledFont&);
+        ScaledFont& operator=(const ScaledFont&);
+    public:
+        cairo_scaled_font_t* font;
+        ScaledFont(cairo_scaled_font_t* font);
+        ~ScaledFont();
+        void TextExtents(const string& s, cairo_text_extents_t& te) const;
+    };
+    typedef boost::shared_ptr<ScaledFont> ScaledFontPtr;
+
+    /**
+     * Settings a scaled font is created for.
+     */
+    struct ScaledFontKey {
+        int ptsize;
+        int style;
+        CairoFontQuality quality;
+        bool operator<(const ScaledFontKey& o) const {
+            if (ptsize != o.ptsize) return ptsize < o.ptsize;
+            if (style != o.style) return style < o.style;
+            return quality < o.quality;
+        }
+    };
+
+    /**
+     * Text rendered on a font texture. The texture records the text
+     * rendered since the last clear so it can be redrawn after
+     * eviction. Textures that render more than MAX_TEXT_OPS texts
+     * without a clear stop recording and are no longer evicted until
+     * they are cleared again.
+     */
+    struct TextOp {
+        string text;
+        int x, y;
+        ScaledFontPtr font;     //!< face, size and quality tier
+        Vector<3,float> colr;
+    };
+
+    class CairoFontTexture : public IFontTextureResource, public ICairoBuffer {
     private:
         cairo_surface_t* surface;
         cairo_t* cr;
         Vector<4,float> clearcol;
+        vector<TextOp> ops;
+        bool recording;
         boost::weak_ptr<CairoFontTexture> weak_this;
         inline void FireChangedEvent(int x, int y, int w, int h);
+        bool Restore();
+        void Draw(TextOp& op);
         friend class CairoFont;
     public:
+        static const unsigned int MAX_TEXT_OPS = 64;
+
         CairoFontTexture(int fixed_width, int fixed_height);
         virtual ~CairoFontTexture();
         
         // texture resource methods
-        void Load() {};
-        void Unload() {};
+        void Load();
+        void Unload();
         void Clear(Vector<4,float> color);
+
+        // buffer methods
+        unsigned int GetBufferSize();
+        bool IsEvictable();
+        void Evict();
     };
 
     typedef boost::shared_ptr<CairoFontTexture> CairoFontTexturePtr;
@@ -65,8 +150,9 @@ private:
     int style;
     Vector<3,float> colr;
     boost::weak_ptr<CairoFont> weak_this;
-    cairo_surface_t* surface;
-    cairo_t* cr;
+    CairoFontQuality quality;
+    map<ScaledFontKey, ScaledFontPtr> scaled; //!< recently used fonts
+    ScaledFontPtr current;  //!< font of the current settings
     cairo_font_slant_t slant;
     cairo_font_weight_t weight;
     friend class CairoFontPlugin;
@@ -74,9 +160,12 @@ private:
     CairoFont();
     CairoFont(string file);
     inline void Init();
+    void SelectScaledFont();
+    void DestroyScaledFonts();
     inline void FireChangedEvent();
 public:
-    
+    static const unsigned int MAX_SCALED_FONTS = 16;
+
     ~CairoFont();
     
     // resource methods
@@ -87,12 +176,15 @@ public:
     IFontTextureResourcePtr CreateFontTexture(int width, int height);
     void RenderText(string s, IFontTextureResourcePtr texr, int x, int y);
     Vector<2,int> TextDim(string s);
+    vector<Vector<2,int> > TextDim(const vector<string>& strings);
     void SetSize(int ptsize);
     int GetSize();
     void SetStyle(int style);
     int GetStyle();
     void SetColor(Vector<3,float> colr);
     Vector<3,float> GetColor();
+    void SetQuality(CairoFontQuality quality);
+    CairoFontQuality GetQuality();
 
 };
 
@@ -0,0 +1,77 @@
+// Cairo font quality tiers.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Resources/CairoFontQuality.h>
+
+namespace OpenEngine {
+namespace Resources {
+
+/**
+ * Create cairo font options for a quality tier.
+ * The caller must release the options with cairo_font_options_destroy.
+ *
+ * @param quality the quality tier.
+ * @return new font options.
+ */
+cairo_font_options_t* CreateFontOptions(CairoFontQuality quality) {
+    cairo_font_options_t* options = cairo_font_options_create();
+    switch (quality) {
+    case FONT_QUALITY_BEST:
+        break;
+    case FONT_QUALITY_BALANCED:
+        cairo_font_options_set_antialias(options, CAIRO_ANTIALIAS_GRAY);
+        cairo_font_options_set_hint_style(options, CAIRO_HINT_STYLE_SLIGHT);
+        cairo_font_options_set_hint_metrics(options, CAIRO_HINT_METRICS_ON);
+        break;
+    case FONT_QUALITY_FAST:
+#if CAIRO_VERSION >= CAIRO_VERSION_ENCODE(1, 12, 0)
+        cairo_font_options_set_antialias(options, CAIRO_ANTIALIAS_FAST);
+#else
+        cairo_font_options_set_antialias(options, CAIRO_ANTIALIAS_GRAY);
+#endif
+        cairo_font_options_set_subpixel_order(options, CAIRO_SUBPIXEL_ORDER_DEFAULT);
+        cairo_font_options_set_hint_style(options, CAIRO_HINT_STYLE_NONE);
+        cairo_font_options_set_hint_metrics(options, CAIRO_HINT_METRICS_ON);
+        break;
+    }
+    return options;
+}
+
+/**
+ * Create a scaled font of a toy font face for a quality tier.
+ * The caller must release the font with cairo_scaled_font_destroy.
+ *
+ * @param family font family or file name.
+ * @param slant font slant.
+ * @param weight font weight.
+ * @param size font size in user space units.
+ * @param quality the quality tier.
+ * @return new scaled font.
+ */
+cairo_scaled_font_t* CreateScaledFont(std::string family,
+                                      cairo_font_slant_t slant,
+                                      cairo_font_weight_t weight,
+                                      double size,
+                                      CairoFontQuality quality) {
+    cairo_font_face_t* face =
+        cairo_toy_font_face_create(family.c_str(), slant, weight);
+    cairo_matrix_t fm, ctm;
+    cairo_matrix_init_scale(&fm, size, size);
+    cairo_matrix_init_identity(&ctm);
+    cairo_font_options_t* options = CreateFontOptions(quality);
+    cairo_scaled_font_t* font =
+        cairo_scaled_font_create(face, &fm, &ctm, options);
+    // the scaled font holds its own references
+    cairo_font_options_destroy(options);
+    cairo_font_face_destroy(face);
+    return font;
+}
+
+} //NS Resources
+} //NS OpenEngine
@@ -0,0 +1,48 @@
+// Cairo font quality tiers.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _CAIRO_FONT_QUALITY_H_
+#define _CAIRO_FONT_QUALITY_H_
+
+#include <cairo.h>
+#include <string>
+
+namespace OpenEngine {
+namespace Resources {
+
+/**
+ * Font rendering quality tiers.
+ * FONT_QUALITY_BEST uses the cairo defaults and is meant for text
+ * that is read closely. FONT_QUALITY_BALANCED uses grayscale
+ * antialiasing and slight hinting. FONT_QUALITY_FAST uses the fastest
+ * antialiasing available, no outline hinting and no subpixel
+ * rendering, and is meant for text that changes every frame.
+ */
+enum CairoFontQuality {
+    FONT_QUALITY_BEST,
+    FONT_QUALITY_BALANCED,
+    FONT_QUALITY_FAST
+};
+
+/**
+ * Number of font quality tiers.
+ */
+const unsigned int FONT_QUALITY_COUNT = 3;
+
+cairo_font_options_t* CreateFontOptions(CairoFontQuality quality);
+cairo_scaled_font_t* CreateScaledFont(std::string family,
+                                      cairo_font_slant_t slant,
+                                      cairo_font_weight_t weight,
+                                      double size,
+                                      CairoFontQuality quality);
+
+} //NS Resources
+} //NS OpenEngine
+
+#endif // _CAIRO_FONT_QUALITY_H_
@@ -0,0 +1,103 @@
+// Cairo pixel memory manager.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Resources/CairoMemoryManager.h>
+
+#include <cstddef>
+
+namespace OpenEngine {
+namespace Resources {
+
+/**
+ * The manager state is constructed on first use and never destroyed,
+ * so buffers released during static destruction remain safe.
+ */
+CairoMemoryManager::State& CairoMemoryManager::GetState() {
+    static State* state = new State();
+    return *state;
+}
+
+/**
+ * Set the pixel memory budget.
+ * Buffers are evicted immediately if the current usage exceeds the
+ * new budget.
+ *
+ * @param bytes budget in bytes, zero for unlimited.
+ */
+void CairoMemoryManager::SetBudget(unsigned int bytes) {
+    GetState().budget = bytes;
+    Enforce(NULL);
+}
+
+unsigned int CairoMemoryManager::GetBudget() {
+    return GetState().budget;
+}
+
+/**
+ * Get the amount of pixel memory held by resident buffers.
+ *
+ * @return usage in bytes.
+ */
+unsigned int CairoMemoryManager::GetUsage() {
+    return GetState().usage;
+}
+
+/**
+ * Register a newly allocated buffer as the most recently used.
+ * Other buffers may be evicted to make room for it, the new buffer
+ * itself is never evicted by this call.
+ */
+void CairoMemoryManager::Allocated(ICairoBuffer* buffer) {
+    Released(buffer);
+    State& s = GetState();
+    unsigned int size = buffer->GetBufferSize();
+    BufferList::iterator itr = s.lru.insert(s.lru.end(), buffer);
+    s.buffers[buffer] = BufferEntry(itr, size);
+    s.usage += size;
+    Enforce(buffer);
+}
+
+/**
+ * Unregister a buffer. Releasing an untracked buffer is a no-op.
+ */
+void CairoMemoryManager::Released(ICairoBuffer* buffer) {
+    State& s = GetState();
+    BufferMap::iterator itr = s.buffers.find(buffer);
+    if (itr == s.buffers.end()) return;
+    s.lru.erase(itr->second.first);
+    s.usage -= itr->second.second;
+    s.buffers.erase(itr);
+}
+
+/**
+ * Mark a buffer as the most recently used.
+ */
+void CairoMemoryManager::Touch(ICairoBuffer* buffer) {
+    State& s = GetState();
+    BufferMap::iterator itr = s.buffers.find(buffer);
+    if (itr == s.buffers.end()) return;
+    s.lru.splice(s.lru.end(), s.lru, itr->second.first);
+}
+
+void CairoMemoryManager::Enforce(ICairoBuffer* keep) {
+    State& s = GetState();
+    if (s.budget == 0) return;
+    BufferList::iterator itr = s.lru.begin();
+    while (s.usage > s.budget && itr != s.lru.end()) {
+        ICairoBuffer* victim = *itr;
+        // advance before evicting as it invalidates the victim's node
+        ++itr;
+        if (victim == keep || !victim->IsEvictable()) continue;
+        victim->Evict();
+        Released(victim);
+    }
+}
+
+} //NS Resources
+} //NS OpenEngine
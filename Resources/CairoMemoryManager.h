@@ -0,0 +1,87 @@
+// Cairo pixel memory manager.
+// -------------------------------------------------------------------
+// Copyright (C) 2007 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _CAIRO_MEMORY_MANAGER_H_
+#define _CAIRO_MEMORY_MANAGER_H_
+
+#include <list>
+#include <map>
+
+namespace OpenEngine {
+namespace Resources {
+
+/**
+ * Pixel buffer tracked by the cairo memory manager.
+ * An evictable buffer must be able to rebuild its pixels the next
+ * time it is accessed.
+ *
+ * @class ICairoBuffer CairoMemoryManager.h Resources/CairoMemoryManager.h
+ */
+class ICairoBuffer {
+public:
+    virtual ~ICairoBuffer() {}
+
+    /**
+     * Size of the resident pixel buffer in bytes.
+     */
+    virtual unsigned int GetBufferSize() = 0;
+
+    /**
+     * True if the buffer can be released and rebuilt on next access.
+     */
+    virtual bool IsEvictable() = 0;
+
+    /**
+     * Release the pixel buffer.
+     */
+    virtual void Evict() = 0;
+};
+
+/**
+ * Cairo pixel memory manager.
+ * Keeps track of the pixel memory of all resident cairo buffers in
+ * least recently used order. When the usage exceeds the budget the
+ * least recently used evictable buffers are released until the usage
+ * is within the budget again. A budget of zero means unlimited.
+ *
+ * The manager is not thread safe and must only be used from the
+ * thread drawing the cairo surfaces.
+ *
+ * @class CairoMemoryManager CairoMemoryManager.h Resources/CairoMemoryManager.h
+ */
+class CairoMemoryManager {
+private:
+    typedef std::list<ICairoBuffer*> BufferList;
+    typedef std::pair<BufferList::iterator, unsigned int> BufferEntry;
+    typedef std::map<ICairoBuffer*, BufferEntry> BufferMap;
+
+    struct State {
+        BufferList lru;
+        BufferMap buffers;
+        unsigned int usage;
+        unsigned int budget;
+        State() : usage(0), budget(0) {}
+    };
+
+    static State& GetState();
+    static void Enforce(ICairoBuffer* keep);
+public:
+    static void SetBudget(unsigned int bytes);
+    static unsigned int GetBudget();
+    static unsigned int GetUsage();
+
+    static void Allocated(ICairoBuffer* buffer);
+    static void Released(ICairoBuffer* buffer);
+    static void Touch(ICairoBuffer* buffer);
+};
+
+} //NS Resources
+} //NS OpenEngine
+
+#endif // _CAIRO_MEMORY_MANAGER_H_
@@ -13,59 +13,365 @@
 
 #include <Logging/Logger.h>
 
+#include <algorithm>
+#include <cstdlib>
+
 namespace OpenEngine {
 namespace Resources {
 
 using OpenEngine::Utils::Convert;
 
-CairoResource::CairoResource(unsigned int width, unsigned int height) 
-    : Texture2D<unsigned char>() {
+/**
+ * Release information attached to the surface of wrapped memory, so
+ * the memory is released when cairo no longer references it.
+ */
+struct CairoRelease {
+    CairoReleaseFunc release;
+    unsigned char* data;
+    void* closure;
+};
+
+static cairo_user_data_key_t releaseKey;
+static cairo_user_data_key_t bufferKey;
+
+static void ReleaseWrapped(void* user) {
+    CairoRelease* r = (CairoRelease*)user;
+    if (r->release) r->release(r->data, r->closure);
+    delete r;
+}
+
+CairoResource::CairoResource(unsigned int width, unsigned int height,
+                             cairo_format_t format) 
+    : Texture2D<unsigned char>()
+    , surface(NULL)
+    , surfaceFormat(format)
+    , bufferSize(0)
+    , redrawer(NULL)
+    , external(false)
+    , converted(false) {
     if (width & (width - 1))
         throw Exception("Invalid width: "+Convert::ToString(width)+", must be a power of two.");
     if (height & (height - 1))
         throw Exception("Invalid height: "+Convert::ToString(height)+", must be a power of two.");
 
-	this->channels = 4;
-    this->format = RGBA;
-	unsigned char* buffer = (unsigned char*)calloc
-        (this->channels * width * height, sizeof(unsigned char));
+    // opaque formats are converted to packed rgb when rebound, see
+    // ConvertTexture
+    switch (format) {
+    case CAIRO_FORMAT_ARGB32:
+        this->channels = 4;
+        this->format = RGBA;
+        break;
+    case CAIRO_FORMAT_RGB24:
+        this->channels = 3;
+        this->format = RGB;
+        break;
+    case CAIRO_FORMAT_RGB16_565:
+        // the in place expansion needs unpadded 565 rows
+        if (width < 2)
+            throw Exception("Invalid width: "+Convert::ToString(width)+", RGB16_565 surfaces must be at least 2 pixels wide.");
+        this->channels = 3;
+        this->format = RGB;
+        break;
+    default:
+        throw Exception("Unsupported cairo format: "+Convert::ToString((int)format));
+    }
+    // the pixel buffer is allocated on first access, see Restore
+	this->data = NULL;
+	this->width = width;
+	this->height = height;
+    this->compression = false;
+    this->mipmapping = false;
+}
+
+CairoResource::CairoResource(unsigned char* data, unsigned int width,
+                             unsigned int height, unsigned int stride,
+                             cairo_format_t format,
+                             CairoReleaseFunc release, void* closure)
+    : Texture2D<unsigned char>()
+    , surface(NULL)
+    , surfaceFormat(format)
+    , bufferSize(stride * height)
+    , redrawer(NULL)
+    , external(true)
+    , converted(true) {
+    if (format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24)
+        throw Exception("Unsupported cairo format for wrapped memory, must be ARGB32 or RGB24.");
+    // texture consumers expect tightly packed rows
+    if (stride != 4 * width)
+        throw Exception("Invalid stride: "+Convert::ToString(stride)+", must be "+Convert::ToString(4 * width)+".");
 
-	//! @TODO : check for memory fail
     surface = cairo_image_surface_create_for_data
-        (buffer, CAIRO_FORMAT_ARGB32, width, height, channels * width);
-	//! @TODO : check for errors
+        (data, format, width, height, stride);
+    cairo_status_t status = cairo_surface_status(surface);
+    if (status != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+        throw Exception("Could not wrap memory: " + 
+                        std::string(cairo_status_to_string(status)));
+    }
+    CairoRelease* r = new CairoRelease();
+    r->release = release;
+    r->data = data;
+    r->closure = closure;
+    if (cairo_surface_set_user_data(surface, &releaseKey, r, ReleaseWrapped)
+        != CAIRO_STATUS_SUCCESS) {
+        delete r;
+        cairo_surface_destroy(surface);
+        throw Exception("Could not wrap memory: out of memory");
+    }
 
-	this->data = cairo_image_surface_get_data(surface);
-	this->width = cairo_image_surface_get_width(surface);
-	this->height = cairo_image_surface_get_height(surface);
+    // advertise the real byte order of the 32 bit pixels, the drawing
+    // tools choose their colour order from the advertised format
+	this->channels = 4;
+    this->format = BGRA;
+	this->data = data;
+	this->width = width;
+	this->height = height;
     this->compression = false;
     this->mipmapping = false;
 }
 
+/**
+ * Create a cairo resource.
+ *
+ * Opaque surfaces can use CAIRO_FORMAT_RGB24 or
+ * CAIRO_FORMAT_RGB16_565 to reduce the texture to three channels,
+ * the latter also reducing the pixel buffer to three bytes per pixel.
+ *
+ * @param width width in pixels, must be a power of two.
+ * @param height height in pixels, must be a power of two.
+ * @param format cairo pixel format of the surface.
+ * @return the new resource.
+ */
 CairoResourcePtr CairoResource::Create(unsigned int width, 
-                                       unsigned int height) {
-    CairoResourcePtr ptr = CairoResourcePtr(new CairoResource(width, height));
+                                       unsigned int height,
+                                       cairo_format_t format) {
+    CairoResourcePtr ptr = CairoResourcePtr(new CairoResource(width, height, format));
+    ptr->weak_this = ptr;
+    return ptr;
+}
+
+/**
+ * Wrap externally owned pixel memory without copying it.
+ * See the class documentation for the required row order, stride
+ * and format. The memory must stay valid until the release function
+ * is called, which happens when the last pointer to the resource is
+ * dropped or the resource is unloaded, and cairo no longer
+ * references the surface. If wrapping fails an exception is thrown
+ * and the caller keeps ownership of the memory.
+ *
+ * Unlike \a Create the dimensions need not be powers of two.
+ *
+ * @param data pointer to the first (bottom) row of pixels.
+ * @param width width in pixels.
+ * @param height height in pixels.
+ * @param stride bytes per row, must be 4 * width.
+ * @param format CAIRO_FORMAT_ARGB32, or CAIRO_FORMAT_RGB24 when the
+ *        alpha channel is ignored by the renderer.
+ * @param release function releasing the memory or NULL.
+ * @param closure user data passed to the release function.
+ * @return the wrapping resource.
+ */
+CairoResourcePtr CairoResource::Wrap(unsigned char* data,
+                                     unsigned int width, unsigned int height,
+                                     unsigned int stride, cairo_format_t format,
+                                     CairoReleaseFunc release, void* closure) {
+    CairoResourcePtr ptr = CairoResourcePtr
+        (new CairoResource(data, width, height, stride, format, release, closure));
     ptr->weak_this = ptr;
     return ptr;
 }
 
 CairoResource::~CairoResource() {
-    //cairo_surface_destroy(surface);
     this->Unload();
 }
 
+/**
+ * Make sure the pixel buffer is resident.
+ * If the buffer has not been allocated yet, or has been evicted, a
+ * new cleared buffer is allocated and the redrawer is asked to
+ * redraw it.
+ *
+ * @return true if a new buffer was allocated.
+ */
+bool CairoResource::Restore() {
+    if (surface) {
+        CairoMemoryManager::Touch(this);
+        return false;
+    }
+    if (external)
+        throw Exception("Wrapped memory has been released.");
+    unsigned int stride = cairo_format_stride_for_width(surfaceFormat, width);
+    cairo_status_t status;
+    if (surfaceFormat == CAIRO_FORMAT_RGB16_565) {
+        // leave room for expanding the pixels to packed rgb in place
+        unsigned int size = std::max(stride * height, 3 * width * height);
+        unsigned char* buffer = (unsigned char*)calloc(size, 1);
+        if (!buffer)
+            throw Exception("Could not allocate "+Convert::ToString(size)+" bytes for cairo surface.");
+        surface = cairo_image_surface_create_for_data
+            (buffer, surfaceFormat, width, height, stride);
+        status = cairo_surface_status(surface);
+        if (status == CAIRO_STATUS_SUCCESS)
+            status = cairo_surface_set_user_data
+                (surface, &bufferKey, buffer, free);
+        // the surface only owns the buffer once the user data is set
+        if (status != CAIRO_STATUS_SUCCESS) free(buffer);
+        bufferSize = size;
+    } else {
+        surface = cairo_image_surface_create(surfaceFormat, width, height);
+        status = cairo_surface_status(surface);
+        bufferSize = stride * height;
+    }
+    if (status != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+        surface = NULL;
+        bufferSize = 0;
+        throw Exception("Could not create cairo surface: " + 
+                        std::string(cairo_status_to_string(status)));
+    }
+	this->data = cairo_image_surface_get_data(surface);
+    converted = false;
+    CairoMemoryManager::Allocated(this);
+    if (redrawer) redrawer->Redraw(this);
+    return true;
+}
+
+/**
+ * Make the pixel data available to the texture loader.
+ * An evicted buffer is redrawn, and a buffer that has not been
+ * converted since it was allocated is converted as by \a
+ * RebindTexture.
+ */
 void CairoResource::Load() {
+    Restore();
+    if (!converted) ConvertTexture();
+}
+
+/**
+ * Release the pixel buffer.
+ * Unless a redrawer is set the contents of the surface are lost.
+ * Wrapped memory is handed to its release function once cairo no
+ * longer references it.
+ */
+void CairoResource::Unload() {
+    if (!surface) return;
+    CairoMemoryManager::Released(this);
+    // contexts created on the surface keep it alive until destroyed
+    cairo_surface_destroy(surface);
+    surface = NULL;
+    bufferSize = 0;
+    this->data = NULL;
+}
+
+/**
+ * Convert the surface pixels in place to the advertised texture
+ * format and flip them to texture orientation. Opaque formats are
+ * packed to three bytes per pixel, so their surface must be redrawn
+ * completely before it is rebound again.
+ */
+void CairoResource::ConvertTexture() {
+    cairo_surface_flush(surface);
+    unsigned char* pixels = (unsigned char*)this->data;
+    unsigned int stride = cairo_image_surface_get_stride(surface);
+    if (surfaceFormat == CAIRO_FORMAT_RGB24) {
+        // front to back as the packed pixels never overtake the source
+        for (unsigned int y = 0; y < height; ++y) {
+            unsigned int* src = (unsigned int*)(pixels + y * stride);
+            unsigned char* dst = pixels + y * width * 3;
+            for (unsigned int x = 0; x < width; ++x) {
+                unsigned int p = src[x];
+                dst[3*x]   = p & 0xff;
+                dst[3*x+1] = (p >> 8) & 0xff;
+                dst[3*x+2] = (p >> 16) & 0xff;
+            }
+        }
+    } else if (surfaceFormat == CAIRO_FORMAT_RGB16_565) {
+        // back to front as the expanded pixels grow past the source
+        for (unsigned int y = height; y-- > 0; ) {
+            unsigned short* src = (unsigned short*)(pixels + y * stride);
+            unsigned char* dst = pixels + y * width * 3;
+            for (unsigned int x = width; x-- > 0; ) {
+                unsigned short p = src[x];
+                unsigned char b = p & 0x1f;
+                unsigned char g = (p >> 5) & 0x3f;
+                unsigned char r = (p >> 11) & 0x1f;
+                dst[3*x]   = (b << 3) | (b >> 2);
+                dst[3*x+1] = (g << 2) | (g >> 4);
+                dst[3*x+2] = (r << 3) | (r >> 2);
+            }
+        }
+    }
+    ReverseVertecally(); //@todo: use blockcopy
+    converted = true;
 }
 
 cairo_surface_t* CairoResource::GetSurface() {
+    Restore();
     return surface;
 }
 
 void CairoResource::RebindTexture() {
-    ReverseVertecally(); //@todo: use blockcopy
+    Restore();
+    // never modify wrapped memory behind the producer's back
+    if (!external)
+        ConvertTexture();
+
+    changedEvent
+        .Notify(Texture2DChangedEventArg(this->weak_this.lock()));
+}
 
+/**
+ * Notify listeners that the texture data has changed without flipping
+ * it. Use this when drawing directly in texture orientation.
+ */
+void CairoResource::NotifyChanged() {
+    converted = true;
     changedEvent
-        .Notify(Texture2DChangedEventArg(this->weak_this));
+        .Notify(Texture2DChangedEventArg(this->weak_this.lock()));
+}
+
+/**
+ * Notify listeners that a range of rows has changed without flipping
+ * the texture data.
+ *
+ * @param y first changed row in texture orientation.
+ * @param h number of changed rows.
+ */
+void CairoResource::NotifyChanged(unsigned int y, unsigned int h) {
+    converted = true;
+    changedEvent
+        .Notify(Texture2DChangedEventArg(this->weak_this.lock(), 0, y, width, h));
+}
+
+/**
+ * Set the redrawer used to restore the surface after eviction.
+ * Only resources with a redrawer are evicted by the \a
+ * CairoMemoryManager.
+ *
+ * @param redrawer redrawer or NULL to pin the buffer.
+ */
+void CairoResource::SetRedrawer(ICairoRedrawer* redrawer) {
+    this->redrawer = redrawer;
+}
+
+bool CairoResource::IsResident() {
+    return surface != NULL;
+}
+
+unsigned int CairoResource::GetBufferSize() {
+    return bufferSize;
+}
+
+cairo_format_t CairoResource::GetSurfaceFormat() {
+    return surfaceFormat;
+}
+
+bool CairoResource::IsEvictable() {
+    return redrawer != NULL && !external;
+}
+
+void CairoResource::Evict() {
+    Unload();
 }
 
 } //NS Resources
@@ -11,6 +11,7 @@
 #define _CAIRO_RESOURCE_H_
 
 #include <Resources/Texture2D.h>
+#include <Resources/CairoMemoryManager.h>
 #include <string>
 #include <cairo.h>
 
@@ -27,35 +28,111 @@ class CairoResource;
  */
 typedef boost::shared_ptr<CairoResource> CairoResourcePtr;
 
+/**
+ * Cairo redraw interface.
+ * Implemented by users that are able to redraw the contents of a
+ * cairo resource after its pixel buffer has been evicted by the
+ * \a CairoMemoryManager. Redraw should only draw on the surface, the
+ * resource takes care of rebinding it.
+ *
+ * @class ICairoRedrawer CairoResource.h Resources/CairoResource.h
+ */
+class ICairoRedrawer {
+public:
+    virtual ~ICairoRedrawer() {}
+    virtual void Redraw(CairoResource* resource) = 0;
+};
+
+/**
+ * Release function for externally owned pixel memory wrapped by a
+ * cairo resource. Called with the wrapped pointer and the closure
+ * given to \a CairoResource::Wrap.
+ */
+typedef void (*CairoReleaseFunc)(unsigned char* data, void* closure);
+
 /**
  * Cairo Image Resource.
  * Integrates a cairo surface with the OpenEngine resource system.
  * The surface is represented as a texture resource and the \a
  * ChangedEvent is used to signal when the surface has been changed by
  * calling the \a RebindTexture method.
- * The raw context for the cairo surface can be accessed by
- * \a GetContext.
+ * The raw cairo surface can be accessed by \a GetSurface.
+ *
+ * The pixel buffer is not allocated until the surface is first
+ * accessed. Resources with a redrawer can have their buffer evicted
+ * by the \a CairoMemoryManager and are redrawn on next access.
+ *
+ * Externally owned memory, such as decoded video frames or shared
+ * memory segments, can be wrapped without copying using \a Wrap.
+ * Wrapped memory is never flipped nor evicted by the resource, so
+ * signal changes with \a NotifyChanged. Its requirements are:
+ * - rows are stored bottom-up, the first row in memory is the bottom
+ *   of the image, matching rebound cairo resources. Draw overlays on
+ *   such memory with a flipped context, as \a CairoTextLayout does.
+ *   The text tools choose their colour order from the advertised
+ *   texture format, so they draw correctly on wrapped memory too.
+ * - rows are packed, the stride must be exactly 4 * width bytes, as
+ *   texture consumers read the rows without a stride.
+ * - the format is CAIRO_FORMAT_ARGB32 or CAIRO_FORMAT_RGB24. Both are
+ *   advertised as four channel BGRA, the byte order of cairo on
+ *   little-endian hosts. The alpha byte of RGB24 memory is undefined,
+ *   cairo may overwrite it when drawing, so its alpha channel must be
+ *   ignored when rendering, for example by drawing it without
+ *   blending.
+ *
+ * The memory is released when the last pointer to the resource is
+ * dropped, or on \a Unload, once cairo no longer references it.
  *
  * @class CairoResource CairoResource.h Resources/CairoResource.h
  */
-class CairoResource : public Texture2D<unsigned char> {
+class CairoResource : public Texture2D<unsigned char>, public ICairoBuffer {
 protected:
     cairo_surface_t* surface;
+    cairo_format_t surfaceFormat;
+    unsigned int bufferSize;
+    ICairoRedrawer* redrawer;
+    bool external;
+    bool converted;         //!< pixels are in texture format
 
-    CairoResource(unsigned int width, unsigned int height);
+    CairoResource(unsigned int width, unsigned int height,
+                  cairo_format_t format = CAIRO_FORMAT_ARGB32);
+    CairoResource(unsigned char* data, unsigned int width,
+                  unsigned int height, unsigned int stride,
+                  cairo_format_t format,
+                  CairoReleaseFunc release, void* closure);
+    bool Restore();
+    void ConvertTexture();
 
 public:
-    ITexture2DPtr weak_this;
+    //! weak so the resource is destroyed with its last shared pointer
+    boost::weak_ptr<ITexture2D> weak_this;
 
    
-    static CairoResourcePtr Create(unsigned int width, unsigned int height);    
-    ~CairoResource();
+    static CairoResourcePtr Create(unsigned int width, unsigned int height,
+                                   cairo_format_t format = CAIRO_FORMAT_ARGB32);
+    static CairoResourcePtr Wrap(unsigned char* data, 
+                                 unsigned int width, unsigned int height,
+                                 unsigned int stride, cairo_format_t format,
+                                 CairoReleaseFunc release = NULL,
+                                 void* closure = NULL);
+    virtual ~CairoResource();
 
     // resource methods
     void Load();
+    void Unload();
 
     cairo_surface_t* GetSurface();
+    cairo_format_t GetSurfaceFormat();
     void RebindTexture();
+    void NotifyChanged();
+    void NotifyChanged(unsigned int y, unsigned int h);
+    void SetRedrawer(ICairoRedrawer* redrawer);
+    bool IsResident();
+
+    // buffer methods
+    unsigned int GetBufferSize();
+    bool IsEvictable();
+    void Evict();
 };
 
 } //NS Resources
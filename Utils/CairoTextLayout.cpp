@@ -0,0 +1,411 @@
+// Cairo paragraph layout.
+// -------------------------------------------------------------------
+// Copyright (C) 2008 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#include <Utils/CairoTextLayout.h>
+
+#include <Core/Exceptions.h>
+#include <algorithm>
+#include <cmath>
+
+namespace OpenEngine {
+namespace Utils {
+
+using namespace OpenEngine::Resources;
+
+static void SplitParagraphs(std::string text, std::vector<std::string>& out) {
+    std::string::size_type pos = 0, end;
+    while ((end = text.find('\n', pos)) != std::string::npos) {
+        out.push_back(text.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    out.push_back(text.substr(pos));
+}
+
+CairoTextLayout::CairoTextLayout(unsigned int width)
+    : lines(0)
+    , redrawAll(true)
+    , scroll(0)
+    , anchorBottom(false)
+    , drawnTop(0)
+    , width(width)
+    , fontName("Monaco")
+    , fontSize(12)
+    , alignment(CairoTextTool::LEFT)
+    , color(Math::Vector<4,float>(1))
+    , quality(FONT_QUALITY_BEST)
+{
+    CreateFont();
+    paragraphs.push_back(Paragraph());
+    Reshape(0);
+}
+
+void CairoTextLayout::CreateFont() {
+    font.reset(CreateScaledFont(fontName, CAIRO_FONT_SLANT_NORMAL,
+                                CAIRO_FONT_WEIGHT_BOLD, fontSize, quality),
+               cairo_scaled_font_destroy);
+}
+
+/**
+ * Break a paragraph into lines that fit the layout width. Words wider
+ * than the layout are put on a line of their own.
+ */
+void CairoTextLayout::Wrap(Paragraph& p) {
+    cairo_text_extents_t te;
+    cairo_scaled_font_text_extents(font.get(), " ", &te);
+    double space = te.x_advance;
+
+    p.lines.clear();
+    Line line;
+    line.width = 0;
+    bool started = false;
+    std::string::size_type pos = 0, end;
+    for (;;) {
+        end = p.text.find(' ', pos);
+        if (end == std::string::npos) end = p.text.size();
+        std::string word = p.text.substr(pos, end - pos);
+        cairo_scaled_font_text_extents(font.get(), word.c_str(), &te);
+        if (started && line.width + space + te.x_advance > width) {
+            p.lines.push_back(line);
+            line.text = word;
+            line.width = te.x_advance;
+        } else if (started) {
+            line.text += " " + word;
+            line.width += space + te.x_advance;
+        } else {
+            line.text = word;
+            line.width = te.x_advance;
+            started = true;
+        }
+        if (end == p.text.size()) break;
+        pos = end + 1;
+    }
+    p.lines.push_back(line);
+}
+
+/**
+ * Re-wrap a single paragraph and mark the rows that must be redrawn.
+ * If the number of lines changes all following rows move and are
+ * marked as well.
+ */
+void CairoTextLayout::Reshape(unsigned int index) {
+    Paragraph& p = paragraphs[index];
+    unsigned int first = FirstLine(index);
+    unsigned int before = p.lines.size();
+    unsigned int total = lines;
+    Wrap(p);
+    lines = lines - before + p.lines.size();
+    if (before == p.lines.size())
+        MarkDirty(first, first + p.lines.size());
+    else
+        MarkDirty(first, std::max(total, lines));
+}
+
+void CairoTextLayout::ReshapeAll() {
+    lines = 0;
+    for (std::vector<Paragraph>::iterator itr = paragraphs.begin();
+         itr != paragraphs.end(); ++itr) {
+        Wrap(*itr);
+        lines += itr->lines.size();
+    }
+    dirty.clear();
+    redrawAll = true;
+}
+
+void CairoTextLayout::MarkDirty(unsigned int from, unsigned int to) {
+    if (from < to) dirty.push_back(RowRange(from, to));
+}
+
+/**
+ * Row index of the first line in a paragraph. Counts from the nearest
+ * end so appending to the last paragraph is cheap.
+ */
+unsigned int CairoTextLayout::FirstLine(unsigned int index) {
+    unsigned int first = 0;
+    if (index < paragraphs.size() / 2) {
+        for (unsigned int i = 0; i < index; ++i)
+            first += paragraphs[i].lines.size();
+    } else {
+        first = lines;
+        for (unsigned int i = index; i < paragraphs.size(); ++i)
+            first -= paragraphs[i].lines.size();
+    }
+    return first;
+}
+
+/**
+ * Index of the paragraph containing a row, also counting from the
+ * nearest end. Rows past the last line give the paragraph count.
+ *
+ * @param row the row to look up.
+ * @param first set to the first row of the paragraph.
+ */
+unsigned int CairoTextLayout::ParagraphAt(unsigned int row, unsigned int& first) {
+    unsigned int index;
+    if (row >= lines) {
+        first = lines;
+        return paragraphs.size();
+    }
+    if (row < lines / 2) {
+        first = 0;
+        index = 0;
+        while (first + paragraphs[index].lines.size() <= row)
+            first += paragraphs[index++].lines.size();
+    } else {
+        first = lines;
+        index = paragraphs.size();
+        while (first > row)
+            first -= paragraphs[--index].lines.size();
+    }
+    return index;
+}
+
+void CairoTextLayout::SetWidth(unsigned int width) {
+    this->width = width;
+    ReshapeAll();
+}
+
+void CairoTextLayout::SetFontName(std::string name) {
+    fontName = name;
+    CreateFont();
+    ReshapeAll();
+}
+
+void CairoTextLayout::SetFontSize(unsigned int size) {
+    fontSize = size;
+    CreateFont();
+    ReshapeAll();
+}
+
+void CairoTextLayout::SetAlignment(CairoTextTool::Alignment alignment) {
+    this->alignment = alignment;
+    redrawAll = true;
+}
+
+void CairoTextLayout::SetColor(Math::Vector<4,float> color) {
+    this->color = color;
+    redrawAll = true;
+}
+
+/**
+ * Set the rendering quality. The metrics of the tiers may differ
+ * slightly, so the text is wrapped again.
+ */
+void CairoTextLayout::SetQuality(CairoFontQuality quality) {
+    this->quality = quality;
+    CreateFont();
+    ReshapeAll();
+}
+
+/**
+ * Scroll the layout so a line is the first visible row. Disables
+ * anchoring to the bottom.
+ */
+void CairoTextLayout::SetScroll(unsigned int line) {
+    scroll = line;
+    anchorBottom = false;
+}
+
+/**
+ * Keep the last line visible by scrolling as lines are added.
+ */
+void CairoTextLayout::SetAnchorBottom(bool enabled) {
+    anchorBottom = enabled;
+}
+
+/**
+ * Replace the text of the layout. Only paragraphs that differ from
+ * the current text are re-wrapped.
+ */
+void CairoTextLayout::SetText(std::string text) {
+    std::vector<std::string> texts;
+    SplitParagraphs(text, texts);
+    unsigned int common = std::min(texts.size(), paragraphs.size());
+    for (unsigned int i = 0; i < common; ++i) {
+        if (paragraphs[i].text == texts[i]) continue;
+        paragraphs[i].text = texts[i];
+        Reshape(i);
+    }
+    if (paragraphs.size() > texts.size()) {
+        unsigned int total = lines;
+        for (unsigned int i = common; i < paragraphs.size(); ++i)
+            lines -= paragraphs[i].lines.size();
+        paragraphs.resize(common);
+        MarkDirty(lines, total);
+    }
+    for (unsigned int i = common; i < texts.size(); ++i) {
+        paragraphs.push_back(Paragraph());
+        paragraphs.back().text = texts[i];
+        Reshape(i);
+    }
+}
+
+/**
+ * Append text to the layout. Only the last paragraph and the new
+ * paragraphs are wrapped.
+ */
+void CairoTextLayout::Append(std::string text) {
+    std::vector<std::string> texts;
+    SplitParagraphs(text, texts);
+    paragraphs.back().text += texts[0];
+    Reshape(paragraphs.size() - 1);
+    for (unsigned int i = 1; i < texts.size(); ++i) {
+        paragraphs.push_back(Paragraph());
+        paragraphs.back().text = texts[i];
+        Reshape(paragraphs.size() - 1);
+    }
+}
+
+/**
+ * Replace the text of a single paragraph.
+ *
+ * @param index paragraph index.
+ * @param text paragraph text without newlines.
+ */
+void CairoTextLayout::SetParagraph(unsigned int index, std::string text) {
+    if (index >= paragraphs.size())
+        throw Core::Exception("paragraph index out of range");
+    if (text.find('\n') != std::string::npos)
+        throw Core::Exception("paragraph text must not contain newlines");
+    if (paragraphs[index].text == text) return;
+    paragraphs[index].text = text;
+    Reshape(index);
+}
+
+std::string CairoTextLayout::GetText() {
+    std::string text;
+    for (unsigned int i = 0; i < paragraphs.size(); ++i) {
+        if (i > 0) text += "\n";
+        text += paragraphs[i].text;
+    }
+    return text;
+}
+
+unsigned int CairoTextLayout::GetParagraphCount() {
+    return paragraphs.size();
+}
+
+unsigned int CairoTextLayout::GetLineCount() {
+    return lines;
+}
+
+unsigned int CairoTextLayout::GetLineHeight() {
+    cairo_font_extents_t fe;
+    cairo_scaled_font_extents(font.get(), &fe);
+    return (unsigned int)ceil(fe.height);
+}
+
+void CairoTextLayout::Draw(CairoResourcePtr resource) {
+    Draw(resource.get());
+}
+
+/**
+ * Draw the changed visible rows of the layout on a resource and
+ * signal a changed event for each range of redrawn rows.
+ */
+void CairoTextLayout::Draw(CairoResource* resource) {
+    // rows are signalled without conversion, see RebindTexture
+    if (resource->GetSurfaceFormat() != CAIRO_FORMAT_ARGB32)
+        throw Core::Exception("CairoTextLayout requires an ARGB32 resource");
+    // an evicted buffer has lost all rows
+    if (!resource->IsResident()) redrawAll = true;
+
+    cairo_surface_t* surface = resource->GetSurface();
+    unsigned int w = resource->GetWidth();
+    unsigned int h = resource->GetHeight();
+    unsigned int lh = GetLineHeight();
+
+    // map layout rows to the visible rows
+    unsigned int visible = (h + lh - 1) / lh;
+    unsigned int top = scroll;
+    if (anchorBottom)
+        top = lines > visible ? lines - visible : 0;
+    if (top != drawnTop) redrawAll = true;
+    unsigned int bottom = top + visible;
+
+    if (redrawAll) {
+        dirty.clear();
+        dirty.push_back(RowRange(top, bottom));
+    }
+    // merge the ranges so each row is drawn and signalled once
+    std::sort(dirty.begin(), dirty.end());
+    std::vector<RowRange> ranges;
+    for (std::vector<RowRange>::iterator itr = dirty.begin();
+         itr != dirty.end(); ++itr) {
+        RowRange r(std::max(itr->first, top), std::min(itr->second, bottom));
+        if (r.first >= r.second) continue;
+        if (!ranges.empty() && r.first <= ranges.back().second)
+            ranges.back().second = std::max(ranges.back().second, r.second);
+        else
+            ranges.push_back(r);
+    }
+
+    cairo_t* context = cairo_create(surface);
+    // draw in texture orientation so single rows can be updated
+    // without flipping the whole surface
+    cairo_translate (context, 0, h);
+    cairo_scale (context, 1, -1);
+    // the same font as used for wrapping, cairo derives it for the
+    // flipped matrix
+    cairo_set_scaled_font (context, font.get());
+    cairo_font_extents_t fe;
+    cairo_scaled_font_extents (font.get(), &fe);
+
+    if (redrawAll) {
+        cairo_set_operator (context, CAIRO_OPERATOR_CLEAR);
+        cairo_paint (context);
+    }
+
+    for (std::vector<RowRange>::iterator itr = ranges.begin();
+         itr != ranges.end(); ++itr) {
+        unsigned int y0 = (itr->first - top) * lh;
+        unsigned int y1 = std::min((itr->second - top) * lh, h);
+
+        if (!redrawAll) {
+            cairo_set_operator (context, CAIRO_OPERATOR_CLEAR);
+            cairo_rectangle (context, 0, y0, w, y1 - y0);
+            cairo_fill (context);
+        }
+
+        cairo_set_operator (context, CAIRO_OPERATOR_OVER);
+        // own buffers are BGRA in memory but advertised as RGBA, only
+        // wrapped memory advertises its real byte order
+        if (resource->GetColorFormat() == BGRA)
+            cairo_set_source_rgba (context, color[0], color[1], color[2], color[3]);
+        else
+            cairo_set_source_rgba (context, color[2], color[1], color[0], color[3]);
+        // walk the paragraphs from the first row of the range
+        unsigned int first;
+        unsigned int p = ParagraphAt(itr->first, first);
+        for (unsigned int r = itr->first; r < itr->second && r < lines; ++r) {
+            while (first + paragraphs[p].lines.size() <= r)
+                first += paragraphs[p++].lines.size();
+            Line& line = paragraphs[p].lines[r - first];
+            double x = 0;
+            if (alignment == CairoTextTool::RIGHT)
+                x = width - line.width;
+            else if (alignment == CairoTextTool::CENTER)
+                x = (width - line.width) / 2;
+            cairo_move_to (context, x, (r - top) * lh + fe.ascent);
+            cairo_show_text (context, line.text.c_str());
+        }
+
+        cairo_surface_flush(surface);
+        if (!redrawAll) resource->NotifyChanged(h - y1, y1 - y0);
+    }
+    cairo_destroy(context);
+    cairo_surface_flush(surface);
+
+    if (redrawAll) resource->NotifyChanged();
+    dirty.clear();
+    drawnTop = top;
+    redrawAll = false;
+}
+
+} // NS Utils
+} // NS OpenEngine
@@ -0,0 +1,117 @@
+// Cairo paragraph layout.
+// -------------------------------------------------------------------
+// Copyright (C) 2008 OpenEngine.dk (See AUTHORS)
+//
+// This program is free software; It is covered by the GNU General
+// Public License version 2 or any later version.
+// See the GNU General Public License for more details (see LICENSE).
+//--------------------------------------------------------------------
+
+#ifndef _CAIRO_TEXT_LAYOUT_
+#define _CAIRO_TEXT_LAYOUT_
+
+#include <Math/Vector.h>
+#include <Utils/CairoTextTool.h>
+#include <Resources/CairoResource.h>
+#include <string>
+#include <vector>
+#include <cairo.h>
+#include <boost/shared_ptr.hpp>
+
+namespace OpenEngine {
+namespace Utils {
+
+/**
+ * Multi-line text layout on cairo resources.
+ * The text is split into paragraphs on newlines and each paragraph
+ * is word wrapped to the layout width. The line breaks are cached,
+ * so editing or appending text only re-wraps the affected paragraphs
+ * and \a Draw only redraws and signals the rows that changed.
+ *
+ * Only the rows that fit on the resource are drawn, starting at the
+ * scroll offset set by \a SetScroll. With \a SetAnchorBottom the
+ * layout scrolls to keep its last line visible, as for a log or chat
+ * panel. Moving the visible rows redraws all of them.
+ *
+ * The rows are drawn directly in texture orientation, so the resource
+ * must not be rebound with \a RebindTexture while it is used by a
+ * layout. For the same reason only ARGB32 resources are supported.
+ *
+ * Usage:
+ * @code
+ * CairoResourcePtr log = CairoResource::Create(512, 512);
+ * CairoTextLayout layout(512);
+ * layout.SetAnchorBottom(true);
+ * layout.Append("first line\n");
+ * layout.Draw(log);
+ * // only the new rows are redrawn
+ * layout.Append("second line\n");
+ * layout.Draw(log);
+ * @endcode
+ *
+ * @class CairoTextLayout CairoTextLayout.h Utils/CairoTextLayout.h
+ */
+class CairoTextLayout {
+private:
+    struct Line {
+        std::string text;
+        double width;
+    };
+    struct Paragraph {
+        std::string text;
+        std::vector<Line> lines;
+    };
+
+    std::vector<Paragraph> paragraphs;
+    typedef std::pair<unsigned int, unsigned int> RowRange;
+    std::vector<RowRange> dirty; //!< row ranges to redraw
+    unsigned int lines;          //!< total number of rows
+    bool redrawAll;
+    unsigned int scroll;         //!< first visible row
+    bool anchorBottom;
+    unsigned int drawnTop;       //!< first visible row at last draw
+
+    unsigned int width;
+    std::string fontName;
+    unsigned int fontSize;
+    CairoTextTool::Alignment alignment;
+    Math::Vector<4,float> color;
+    Resources::CairoFontQuality quality;
+    boost::shared_ptr<cairo_scaled_font_t> font;
+
+    void CreateFont();
+    void Wrap(Paragraph& p);
+    void Reshape(unsigned int index);
+    void ReshapeAll();
+    void MarkDirty(unsigned int from, unsigned int to);
+    unsigned int FirstLine(unsigned int index);
+    unsigned int ParagraphAt(unsigned int row, unsigned int& first);
+public:
+    CairoTextLayout(unsigned int width);
+
+    void SetWidth(unsigned int width);
+    void SetFontName(std::string name);
+    void SetFontSize(unsigned int size);
+    void SetAlignment(CairoTextTool::Alignment alignment);
+    void SetColor(Math::Vector<4,float> color);
+    void SetQuality(Resources::CairoFontQuality quality);
+    void SetScroll(unsigned int line);
+    void SetAnchorBottom(bool enabled);
+
+    void SetText(std::string text);
+    void Append(std::string text);
+    void SetParagraph(unsigned int index, std::string text);
+    std::string GetText();
+
+    unsigned int GetParagraphCount();
+    unsigned int GetLineCount();
+    unsigned int GetLineHeight();
+
+    void Draw(Resources::CairoResourcePtr resource);
+    void Draw(Resources::CairoResource* resource);
+};
+
+} // NS Utils
+} // NS OpenEngine
+
+#endif // _CAIRO_TEXT_LAYOUT_
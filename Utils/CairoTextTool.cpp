@@ -7,6 +7,25 @@ namespace Utils {
 
 using namespace OpenEngine::Resources;
 
+void CairoTextTool::ResetFonts() {
+    for (unsigned int i = 0; i < FONT_QUALITY_COUNT; ++i)
+        fonts[i].reset();
+}
+
+/**
+ * Get the scaled font for the current name, size and quality tier.
+ * The fonts are cached so drawing does not set up the font again.
+ */
+cairo_scaled_font_t* CairoTextTool::GetFont() {
+    boost::shared_ptr<cairo_scaled_font_t>& font = fonts[quality];
+    if (!font)
+        font.reset(CreateScaledFont(fontName, CAIRO_FONT_SLANT_NORMAL,
+                                    CAIRO_FONT_WEIGHT_BOLD, fontSize,
+                                    quality),
+                   cairo_scaled_font_destroy);
+    return font.get();
+}
+
 void CairoTextTool::DrawText(std::string text, CairoResourcePtr resource) {
     DrawText(text, resource.get());
 }
@@ -22,10 +41,7 @@ void CairoTextTool::DrawText(std::string text, CairoResource* resource) {
 
     // get ready with the font tool
     cairo_set_operator (context, CAIRO_OPERATOR_OVER);
-    cairo_select_font_face (context, fontName.c_str(), 
-                            CAIRO_FONT_SLANT_NORMAL,
-                            CAIRO_FONT_WEIGHT_BOLD);
-    cairo_set_font_size (context, fontSize);
+    cairo_set_scaled_font (context, GetFont());
 
     // get the the text dimensions
     cairo_text_extents_t extents;
@@ -43,6 +59,11 @@ void CairoTextTool::DrawText(std::string text, CairoResource* resource) {
             cairo_move_to(context, 
                           resource->GetWidth()-1 - textWidth,
                           resource->GetHeight()-1 - shadowoffset);
+        } else if (alignment == CENTER) {
+            cairo_move_to(context, 
+                          ((int)resource->GetWidth() - (int)textWidth) / 2
+                          + shadowoffset,
+                          resource->GetHeight()-1 - shadowoffset);
         } else
             throw Core::Exception("unsupported alignment on cairo resource");
         
@@ -58,13 +79,21 @@ void CairoTextTool::DrawText(std::string text, CairoResource* resource) {
         cairo_move_to(context, 
                       resource->GetWidth()-1 - textWidth - shadowoffset,
                       resource->GetHeight()-1);
+    } else if (alignment == CENTER) {
+        cairo_move_to(context, 
+                      ((int)resource->GetWidth() - (int)textWidth) / 2,
+                      resource->GetHeight()-1);
     } else
         throw Core::Exception("unsupported alignment on cairo resource");
 
     // draw the text 
     Math::Vector<4,float> c = color;
-    // @todo: why do this need to be BGRA to work properly?
-    cairo_set_source_rgba (context, c[2], c[1], c[0], c[3]); 
+    // own buffers are BGRA in memory but advertised as RGBA or RGB,
+    // only wrapped memory advertises its real byte order
+    if (resource->GetColorFormat() == BGRA)
+        cairo_set_source_rgba (context, c[0], c[1], c[2], c[3]);
+    else
+        cairo_set_source_rgba (context, c[2], c[1], c[0], c[3]);
     cairo_show_text (context, text.c_str());
 
 	cairo_restore(context);
@@ -13,7 +13,9 @@
 #include <Math/Vector.h>
 #include <string>
 #include <cairo.h>
+#include <boost/shared_ptr.hpp>
 #include <Resources/CairoResource.h>
+#include <Resources/CairoFontQuality.h>
 
 namespace OpenEngine {
 namespace Utils {
@@ -36,14 +38,16 @@ public:
         alignment = LEFT;
         shadows = false;
         color = Math::Vector<4,float>(1);
+        quality = Resources::FONT_QUALITY_BEST;
     }
     ~CairoTextTool() {}
     
-    void SetFontName(std::string name) { fontName = name; }
-    void SetFontSize(unsigned int size) { fontSize = size; }
+    void SetFontName(std::string name) { fontName = name; ResetFonts(); }
+    void SetFontSize(unsigned int size) { fontSize = size; ResetFonts(); }
     void SetAlignment(Alignment alignment) { this->alignment = alignment; }
     void Shadows(bool enabled) { this->shadows = enabled; }
     void SetColor(Math::Vector<4,float> color) { this->color = color; }
+    void SetQuality(Resources::CairoFontQuality quality) { this->quality = quality; }
 
     void DrawText(std::string, Resources::CairoResourcePtr resource);
     void DrawText(std::string, Resources::CairoResource* resource);
@@ -54,6 +58,12 @@ protected:
     Alignment alignment;
     bool shadows;
     Math::Vector<4,float> color;
+    Resources::CairoFontQuality quality;
+    //! scaled fonts per quality tier, created on first use
+    boost::shared_ptr<cairo_scaled_font_t> fonts[Resources::FONT_QUALITY_COUNT];
+
+    void ResetFonts();
+    cairo_scaled_font_t* GetFont();
 };
 
 } // NS Utils
@@ -21,8 +21,11 @@ FPSSurface::FPSSurface()
     , interval(2000000)
 {
     text.SetFontSize(32);
+    // the readout changes constantly, trade quality for speed
+    text.SetQuality(Resources::FONT_QUALITY_FAST);
     fpsString = "FPS:?.?";
-    text.DrawText(fpsString, this);
+    // the text is drawn when the surface is first accessed
+    SetRedrawer(this);
     timer.Start();
 }
 
@@ -51,6 +54,7 @@ void FPSSurface::Handle(Core::ProcessEventArg arg) {
 	std::string time = Convert::ToString(timestring);
 
 	if (fpsString != time) {
+	    fpsString = time;
 	    text.DrawText(time, this);
 	    RebindTexture();
 	}
@@ -59,5 +63,9 @@ void FPSSurface::Handle(Core::ProcessEventArg arg) {
     }
 }
 
+void FPSSurface::Redraw(Resources::CairoResource* resource) {
+    text.DrawText(fpsString, resource);
+}
+
 } // NS Utils
 } // NS OpenEngine
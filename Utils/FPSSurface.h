@@ -47,7 +47,8 @@ typedef boost::shared_ptr<FPSSurface> FPSSurfacePtr;
  */
 class FPSSurface
     : public Core::IListener<Core::ProcessEventArg>
-    , public Resources::CairoResource {
+    , public Resources::CairoResource
+    , public Resources::ICairoRedrawer {
 private:
     unsigned int frames, interval;
     std::string fpsString;
@@ -58,6 +59,7 @@ public:
     static FPSSurfacePtr Create();
     virtual ~FPSSurface();
     void Handle(Core::ProcessEventArg arg);
+    void Redraw(Resources::CairoResource* resource);
 };
 
 } // NS Utils